@@ -9,6 +9,27 @@
 * 
 * The graph is stored as an adjaceny list.
 *
+* Running with --dynamic-bench [V] [E] [updates] benchmarks the dynamic MST
+* (dynamic_mst.h) against re-running boruvka() after every change.
+*
+* For graphs too large for memory, --pack graph.txt edges.bin converts the CSV
+* into a binary edge file and --external edges.bin [V] runs the semi-external
+* version of the algorithm on it (external_mst.h).
+*
+* --clusters k splits graph.txt into k single-linkage clusters and prints the
+* cluster of every vertex: the MST with its k-1 heaviest edges cut (clustering.h).
+*
+* --binary-out mst.bin writes the MST of graph.txt as binary records instead of
+* printing it (mst_writer.h).
+*
+* --ids int|uint32|uint64 and --weights int|uint16|float|double pick the vertex and
+* edge id type and the weight type graph.txt is read with (--float-weights is short
+* for --weights float). They can follow any of the modes that read graph.txt.
+*
+* --batch [threads] solves a stream of graphs read from stdin on a thread pool
+* (see common/batch_runner.h for the job format). Jobs with malformed lines or
+* vertex ids outside 0..BATCH_MAX_VERTICES-1 get an "Error: ..." line.
+*
 *
 *
 * Paul Bupe Jr
@@ -37,224 +58,386 @@ A visual representation of the weighted graph contained in graph.txt
 */
 
 #include "stdafx.h"
+#include "graph.h"
+#include "boruvka.h"
+#include "dynamic_mst.h"
+#include "external_mst.h"
+#include "clustering.h"
+#include "mst_writer.h"
+#include "../../common/batch_runner.h"
 #include <string>
 #include <iostream>
 #include <vector>
-#include <list>
 #include <utility>
 #include <fstream>
 #include <algorithm>
 #include <iterator>
 #include <set>
+#include <random>
+#include <chrono>
+#include <cstdlib>
+#include <cstdio>
+#include <tuple>
+#include <climits>
+#include <cerrno>
 
 
 // Input file. Expects a single comma separated weighted edge per line
 std::ifstream input("graph.txt");
 
-// Representation of a weighted edge
-struct Edge
+// Turns the edges read from a file into the edge list and adjacency list boruvka()
+// takes. raw_graph is sorted in place and num_v is set to the number of vertices.
+// Returns false if there are more edges than the edge id type E can number.
+template <typename V, typename W, typename E>
+bool prepare_graph(std::vector<BasicEdge<V, W>> &raw_graph, std::vector<BasicEdge<V, W>> &edge_list, AdjList<V, E> &adj_list, V &num_v)
 {
-	int src, dest, weight;
+	// Since we're dealing with an undirected graph, (x,y) == (y,x). Keep the lightest
+	// copy of every edge by sorting on the vertex pair and then the weight.
+	for (auto &v : raw_graph) { if (v.dest < v.src) std::swap(v.src, v.dest); }
+	std::sort(raw_graph.begin(), raw_graph.end(), [](const auto& lhs, const auto& rhs)
+	{return std::tie(lhs.src, lhs.dest, lhs.weight) < std::tie(rhs.src, rhs.dest, rhs.weight); });
+
+	edge_list.clear();
+	std::unique_copy(raw_graph.begin(), raw_graph.end(), std::back_inserter(edge_list), [](const auto& lhs, const auto& rhs)
+	{return (lhs.src == rhs.src) && (lhs.dest == rhs.dest); });
+
+	// Sort the edges by weight so edge ids follow weight order
+	std::sort(edge_list.begin(), edge_list.end(), [](const auto& lhs, const auto& rhs) {return lhs.weight < rhs.weight; });
+
+	// Build the adjacency list, one entry per vertex in the file
+	num_v = 0;
+	for (auto const& v : edge_list) { num_v = std::max(num_v, V(v.dest + 1)); }
+	return build_adj_list(adj_list, num_v, edge_list);
+}
+
+
+// Reads a graph csv file, then writes its MST (or its k clusters when cluster_k > 0)
+template <typename V, typename W, typename E>
+int solve_graph_file(std::istream &in, V cluster_k, const std::string &binary_out)
+{
+	// From our input file
+	std::vector<BasicEdge<V, W>> raw_graph;
 
-	// Overload the >> operator to make parsing the input file cleaner
-	friend std::istream& operator >>(std::istream& is, Edge& v)
+	// Read the file a line at a time so a bad line is reported instead of silently
+	// ending the input. Ids must also leave room for num_v = id + 1.
+	std::string line;
+	for (long long line_no = 1; std::getline(in, line); line_no++)
 	{
-		char ch;
-		is >> v.src >> ch >> v.dest >> ch >> v.weight;
-		return is;
+		if (line.find_first_not_of(" \t\r") == std::string::npos) continue;
+
+		const char *p = line.c_str();
+		BasicEdge<V, W> e;
+		if (!parse_edge_line(p, e, (unsigned long long)std::numeric_limits<V>::max()))
+		{
+			std::cerr << "Bad edge or value out of range on line " << line_no << ": " << line << std::endl;
+			return 1;
+		}
+		raw_graph.push_back(e);
 	}
-};
 
-// Returns a full edge given just the weight of the edge
-Edge edge_from_weight(std::vector<Edge> &edge_list, int weight)
-{
-	Edge empty_edge = { -1,-1,-1 };
-	auto edge = std::find_if(edge_list.begin(), edge_list.end(), [&](const auto& e)
-	{return (e.weight == weight); });
-	return (edge != edge_list.end()) ? (*edge) : empty_edge;
-}
+	// Define an edge and adjacency list
+	std::vector<BasicEdge<V, W>> edge_list;
+	AdjList<V, E> adj_list;
+	V num_v;
+	if (!prepare_graph(raw_graph, edge_list, adj_list, num_v))
+	{
+		std::cerr << "Too many edges for the edge id type, try --ids uint64" << std::endl;
+		return 1;
+	}
 
+	if (cluster_k > 0)
+	{
+		std::vector<V> labels = boruvka_clusters(adj_list, edge_list, cluster_k);
 
-// Utilizing disjoint sets to handle the merging of all the sets (collections) we create
-// This requires find() and union() methods for identifying which set an edge belongs to 
-// and for merging sets.
+		std::cout << "Clusters are: ";
+		for (V i = 0; i < num_v; i++)
+		{
+			std::cout << '{' << i << ',' << labels[i] << std::string("} ");
+		}
+		std::cout << std::endl;
+		return 0;
+	}
 
-struct Set
-{
-	int parent;
-	int rank;
-};
+	// Run the algorithm
+	BasicMSTResult<E, W> mst = boruvka(adj_list, edge_list);
 
-int ds_find(std::vector<Set> &sets, int i)
-{
-	// Find root and make root as parent of i
-	if (sets[i].parent != i) sets[i].parent = ds_find(sets, sets[i].parent);
-	return sets[i].parent;
+	// Display the results
+	if (!binary_out.empty())
+	{
+		std::FILE *out = std::fopen(binary_out.c_str(), "wb");
+		if (!out)
+		{
+			std::cerr << "Could not open the output file!" << std::endl;
+			return 1;
+		}
+		{
+			MSTWriter writer(out, true);
+			writer.begin<V, W>(mst.cost, mst.edge_ids.size());
+			for (E id : mst.edge_ids) { writer.edge(edge_list[id]); }
+			writer.end();
+		}
+		std::fclose(out);
+		return 0;
+	}
+
+	MSTWriter writer(stdout);
+	writer.begin<V, W>(mst.cost, mst.edge_ids.size());
+	for (E id : mst.edge_ids) { writer.edge(edge_list[id]); }
+	writer.end();
+	return 0;
 }
 
-// This function is a third party implementation of union by rank
-// Nothing special going on here. 
-// https://www.geeksforgeeks.org/union-find-algorithm-set-2-union-by-rank/
 
-void ds_union(std::vector<Set> &sets, int x, int y)
+// Buffers for one --batch worker, reused for every job it solves
+struct BatchWorkspace
 {
-	int xroot = ds_find(sets, x);
-	int yroot = ds_find(sets, y);
+	std::vector<Edge> raw_graph;
+	std::vector<Edge> edge_list;
+	AdjList<int, int> adj_list;
+	BoruvkaWorkspace<int, int> boruvka;
+	MSTResult mst;
+};
 
-	// Attach smaller rank tree under root of higher rank tree
-	if (sets[xroot].rank < sets[yroot].rank)
-	{
-		sets[xroot].parent = yroot;
-	}
-	else if (sets[xroot].rank > sets[yroot].rank)
+// Vertex ids in a --batch job must be below this. Jobs come from an untrusted stream,
+// and the id decides how large the adjacency list gets.
+const int BATCH_MAX_VERTICES = 1 << 22;
+
+// Solves one --batch job: the lines of a graph csv file. A malformed job gets an
+// error line instead of a result.
+void solve_batch_job(BatchWorkspace &ws, const std::string &job, std::string &result)
+{
+	// Parse "src,dest,weight" lines without going through a stringstream
+	ws.raw_graph.clear();
+	const char *p = job.c_str();
+	for (int line = 1; *p != '\0'; line++)
 	{
-			sets[yroot].parent = xroot;
+		// Skip blank lines
+		while (*p == ' ' || *p == '\t' || *p == '\r') p++;
+		if (*p == '\n') { p++; continue; }
+		if (*p == '\0') break;
+
+		Edge e;
+		if (!parse_edge_line(p, e, BATCH_MAX_VERTICES))
+		{
+			result += "Error: bad edge on line " + std::to_string(line) + "\n";
+			return;
+		}
+		ws.raw_graph.push_back(e);
 	}
-	// If ranks are same, then make one as root and increment its rank by one
-	else
+
+	int num_v;
+	if (!prepare_graph(ws.raw_graph, ws.edge_list, ws.adj_list, num_v))
 	{
-		sets[yroot].parent = xroot;
-		sets[xroot].rank++;
+		result += "Error: too many edges\n";
+		return;
 	}
+	boruvka(ws.adj_list, ws.edge_list, ws.boruvka, ws.mst);
+
+	MSTWriter writer(result);
+	writer.begin<int, int>(ws.mst.cost, ws.mst.edge_ids.size());
+	for (int id : ws.mst.edge_ids) { writer.edge(ws.edge_list[id]); }
+	writer.end();
 }
 
-// The main algorithm
-std::vector<std::pair<int, std::list<Edge>>> boruvka(std::vector<std::list<std::pair<int, int>>> &adj_list, std::vector<Edge> &edge_list)
+
+// Benchmark for the dynamic MST (run as: boruvka --dynamic-bench [V] [E] [updates])
+// Builds a random connected graph, applies a stream of random inserts, deletes and
+// weight changes, and compares that against re-running boruvka() from scratch.
+// The two costs are cross-checked at every sample so the benchmark doubles as a test.
+int dynamic_benchmark(int num_v, int num_e, int num_updates)
 {
-	int num_v = adj_list.size();
-	int total_weight = 0;
-	int collections = num_v;
-	int path_cost = 0;
+	typedef std::chrono::steady_clock clock;
+	const int sample_every = std::max(1, num_updates / 10);
 
-	std::vector<std::pair<int, std::list<Edge>>> mst;
-	std::list<Edge> mst_edges;
-	std::vector<Set> sets;
-	std::vector<int> cheapest_edge;
+	std::mt19937 rng(7432);
 
-	// Initialize our sets
-	for (int i = 0; i < num_v; i++) { sets.push_back({ i, 0 }); }
+	std::uniform_int_distribution<int> weight(1, 1000000);
 
-	while (collections > 1)
+	// A path through every vertex keeps the graph connected, the rest is random.
+	// Only the random edges are ever deleted.
+	std::vector<Edge> edge_list;
+	for (int i = 0; i + 1 < num_v; i++) { edge_list.push_back({ i, i + 1, weight(rng) }); }
+	while ((int)edge_list.size() < num_e)
 	{
-		// Maintain a list of cheapest edges
-		for (int i = 0; i < num_v; i++) { cheapest_edge.push_back(-1); }
+		int u = rng() % num_v, v = rng() % num_v;
+		if (u != v) edge_list.push_back({ u, v, weight(rng) });
+	}
 
-		// Calculate the minimum outgoing weights from each set
-		for (int i = 0; i < num_v; i++)
+	auto start = clock::now();
+	DynamicMST dyn(num_v, edge_list);
+	double seed_time = std::chrono::duration<double>(clock::now() - start).count();
+
+	// Live edge ids, with the position of every id so deletes are O(1) swap-removes
+	// and the bookkeeping does not count against the dynamic MST's time
+	std::vector<int> all_ids(edge_list.size());
+	for (int i = 0; i < (int)all_ids.size(); i++) { all_ids[i] = i; }
+	std::vector<int> all_pos(all_ids);
+	std::vector<int> removable(all_ids.begin() + std::max(0, num_v - 1), all_ids.end());
+
+	std::vector<Edge> current;
+	AdjList<int, int> adj_list;
+	double dynamic_time = 0;
+	double full_time = 0;
+	int full_runs = 0;
+
+	for (int done = 0; done < num_updates; )
+	{
+		// Apply a batch of updates
+		start = clock::now();
+		for (int b = 0; b < sample_every && done < num_updates; b++, done++)
 		{
-			int src_set = ds_find(sets, i);
-			std::pair<int, int> cheapest = { -1, -1 };
-			for (auto const &list : adj_list[i])
-			{
-				int dest_set = ds_find(sets, list.first);
-				if (src_set != dest_set) {
-					cheapest.first = list.first;
-					cheapest.second = list.second;
-					break;	// Since the adjacency list is sorted, the first valid edge is always the cheapest
-				}
+			int op = rng() % 3;
+			if (op == 1 && !removable.empty()) {
+				int k = rng() % removable.size();
+				int id = removable[k];
+				removable[k] = removable.back();
+				removable.pop_back();
+				all_ids[all_pos[id]] = all_ids.back();
+				all_pos[all_ids.back()] = all_pos[id];
+				all_ids.pop_back();
+				dyn.delete_edge(id);
+			}
+			else if (op == 2) {
+				dyn.update_weight(all_ids[rng() % all_ids.size()], weight(rng));
+			}
+			else {
+				int u = rng() % num_v, v = rng() % num_v;
+				if (u == v) v = (u + 1) % num_v;
+				int id = dyn.insert_edge(u, v, weight(rng));
+				if (id >= (int)all_pos.size()) all_pos.resize(id + 1);
+				all_pos[id] = (int)all_ids.size();
+				all_ids.push_back(id);
+				removable.push_back(id);
 			}
-			cheapest_edge[src_set] = (cheapest_edge[src_set] == -1 || cheapest_edge[src_set] > cheapest.second) ? cheapest.second : cheapest_edge[src_set];
 		}
-
-		// Using a disjoint set, merge set and populate the MST
-		for (int i = 0; i < num_v; i++)
+		dynamic_time += std::chrono::duration<double>(clock::now() - start).count();
+
+		// Full recomputation of the same graph, adjacency list build included
+		start = clock::now();
+		current.clear();
+		for (int id : all_ids) { current.push_back(dyn.edge(id)); }
+		build_adj_list(adj_list, num_v, current);
+		MSTResult mst = boruvka(adj_list, current);
+		full_time += std::chrono::duration<double>(clock::now() - start).count();
+		full_runs++;
+
+		if (mst.cost != dyn.current_cost() || (int)mst.edge_ids.size() != dyn.tree_size())
 		{
-			if (cheapest_edge[i] != -1)
-			{
-				Edge cheapest = edge_from_weight(edge_list, cheapest_edge[i]);
-
-				int src_set = ds_find(sets, cheapest.src);
-				int dest_set = ds_find(sets, cheapest.dest);
-
-				if (src_set != dest_set) {
-					mst_edges.push_back(cheapest);
-					path_cost += cheapest.weight;
-					ds_union(sets, src_set, dest_set);
-					collections--;
-				}
-			}
+			std::cerr << "Mismatch after " << done << " updates: boruvka cost " << mst.cost
+				<< ", dynamic cost " << dyn.current_cost() << std::endl;
+			return 1;
 		}
-
-		cheapest_edge.clear();
 	}
 
-	mst.push_back({ path_cost, mst_edges });
+	double dynamic_rate = num_updates / dynamic_time;
+	double full_rate = full_runs / full_time;
+
+	std::cout << "Graph: " << num_v << " vertices, " << num_e << " edges, " << num_updates << " updates\n";
+	std::cout << "Seeding the dynamic MST took " << seed_time * 1000 << " ms\n";
+	std::cout << "Dynamic MST:     " << dynamic_rate << " updates/s\n";
+	std::cout << "Full recompute:  " << full_rate << " updates/s (" << full_time / full_runs * 1000 << " ms per run)\n";
+	std::cout << "Speedup:         " << dynamic_rate / full_rate << "x\n";
+	std::cout << "Final MST cost:  " << dyn.current_cost() << std::endl;
 
-	return mst;
+	return 0;
 }
 
 
-int main()
+// Reads graph.txt with the weight type named by --weights. Every id and weight
+// combination is instantiated through here, so all of them are built.
+template <typename V>
+int solve_with_ids(const std::string &weights, int cluster_k, const std::string &binary_out)
 {
-	// Define an adjaceny list using a vector that contains a list
-	std::vector<std::list<std::pair<int, int>>> adj_list(7);
+	if (weights == "int") return solve_graph_file<V, int, V>(input, V(cluster_k), binary_out);
+	if (weights == "uint16") return solve_graph_file<V, uint16_t, V>(input, V(cluster_k), binary_out);
+	if (weights == "float") return solve_graph_file<V, float, V>(input, V(cluster_k), binary_out);
+	if (weights == "double") return solve_graph_file<V, double, V>(input, V(cluster_k), binary_out);
 
-	// Define an edge list
-	std::vector<Edge> edge_list;
+	std::cerr << "Unknown weight type " << weights << std::endl;
+	return 1;
+}
 
-	// From our input file
-	std::vector<Edge> raw_graph;
 
-	// Read data from graph csv file
-	if (!input)
+int main(int argc, char *argv[])
+{
+	if (argc > 1 && std::string(argv[1]) == "--dynamic-bench")
 	{
-		std::cerr << "Could not open the file!" << std::endl;
-		return 1;
+		int num_v = (argc > 2) ? std::atoi(argv[2]) : 2000;
+		int num_e = (argc > 3) ? std::atoi(argv[3]) : 20000;
+		int num_updates = (argc > 4) ? std::atoi(argv[4]) : 20000;
+		return dynamic_benchmark(num_v, num_e, num_updates);
 	}
-	else
+
+	if (argc > 1 && std::string(argv[1]) == "--batch")
 	{
-		// Read file and store in vector using some lovely STL magic
-		std::copy(std::istream_iterator<Edge>(input),
-			std::istream_iterator<Edge>(),
-			std::back_inserter(raw_graph)
-		);
-		input.close();
+		std::ios::sync_with_stdio(false);
+		unsigned num_threads = (argc > 2) ? std::atoi(argv[2]) : 0;
+		run_batch<BatchWorkspace>(std::cin, stdout, solve_batch_job, num_threads);
+		return 0;
 	}
 
-	// Sort the raw graph data by edge weight
-	std::sort(raw_graph.begin(), raw_graph.end(), [](const auto& lhs, const auto& rhs) {return lhs.weight < rhs.weight; });
-
-	// Build adjecency and edge lists
-	for (auto const& v : raw_graph)
+	if (argc > 3 && std::string(argv[1]) == "--pack")
 	{
-		adj_list[v.src].push_back(std::make_pair(v.dest, v.weight));
-		
-
-		if (edge_list.empty())
+		int num_v = pack_edge_file(argv[2], argv[3]);
+		if (num_v < 0)
 		{
-			edge_list.push_back(v);
-			//std::cout << "Added edge to list: " << v.src << " " << v.dest << " " << v.weight << std::endl;
+			std::cerr << "Could not convert the file, or it holds invalid edges!" << std::endl;
+			return 1;
 		}
-		else
+		std::cout << "Wrote " << argv[3] << " (" << num_v << " vertices)" << std::endl;
+		return 0;
+	}
+
+	if (argc > 2 && std::string(argv[1]) == "--external")
+	{
+		std::string edge_file = argv[2];
+		int num_v = (argc > 3) ? std::atoi(argv[3]) : count_vertices(edge_file);
+		std::vector<Edge> mst_edges;
+		long long path_cost = 0;
+		if (num_v < 0 || !semi_external_boruvka(edge_file, num_v, edge_file + ".scratch", mst_edges, path_cost))
 		{
-			// Since we're dealing with an undirected graph, (x,y) == (y,x)
-			// Using a lambda as the find_if predicate
-			auto it = std::find_if(edge_list.begin(), edge_list.end(), [&](const auto& e)
-			{return ((e.src == v.src) && (e.dest == v.dest)) ||
-				((e.src == v.dest) && (e.dest == v.src)); });
-			
-			// If this edge is not in the edge_list then add it!
-			if (it == edge_list.end())
-			{
-				edge_list.push_back(v);
-				//std::cout << "Added edge to list: " << v.src << " " << v.dest << " " << v.weight << std::endl;
-			}
+			std::cerr << "Could not read the edge file, or it holds invalid edges!" << std::endl;
+			return 1;
 		}
+
+		MSTWriter writer(stdout);
+		writer.begin<int, int>(path_cost, mst_edges.size());
+		for (auto const &edges : mst_edges) { writer.edge(edges); }
+		writer.end();
+		return 0;
 	}
 
-	// Run the algorithm
-	std::vector<std::pair<int, std::list<Edge>>> mst = boruvka(adj_list, edge_list);
+	// Number of clusters to cut the graph into, 0 to print the MST instead
+	int cluster_k = (argc > 2 && std::string(argv[1]) == "--clusters") ? std::atoi(argv[2]) : 0;
 
-	
-	// Display the results
-	std::cout << "Total path cost is: " << mst[0].first << std::endl;
-	std::cout << "MST is: ";
+	// Write the MST as binary records to this file instead of printing it
+	std::string binary_out = (argc > 2 && std::string(argv[1]) == "--binary-out") ? argv[2] : "";
 
-	for (auto const &edges : mst[0].second)
+	// Read data from graph csv file
+	if (!input)
 	{
-		std::cout << '{' << edges.src << ',' << edges.dest << std::string("} ");
+		std::cerr << "Could not open the file!" << std::endl;
+		return 1;
 	}
-	std::cout << std::endl;
+
+	// Id and weight types to read graph.txt with
+	std::string ids = "int", weights = "int";
+	for (int i = 1; i < argc; i++)
+	{
+		std::string arg = argv[i];
+		if (arg == "--float-weights") weights = "float";
+		else if (arg == "--ids" && i + 1 < argc) ids = argv[++i];
+		else if (arg == "--weights" && i + 1 < argc) weights = argv[++i];
+	}
+
+	int result = 1;
+	if (ids == "int") result = solve_with_ids<int>(weights, cluster_k, binary_out);
+	else if (ids == "uint32") result = solve_with_ids<uint32_t>(weights, cluster_k, binary_out);
+	else if (ids == "uint64") result = solve_with_ids<uint64_t>(weights, cluster_k, binary_out);
+	else std::cerr << "Unknown id type " << ids << std::endl;
+	input.close();
+
+	if (result != 0 || argc > 1) return result;
 
 	// Pause the command prompt so the results can be seen.
 	std::cin.get();
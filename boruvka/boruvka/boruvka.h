@@ -0,0 +1,101 @@
+﻿/**
+* Boruvka's algorithm on an adjacency list
+*
+* Every round finds the cheapest edge leaving each component and merges along all
+* of them, so there are at most log2(V) rounds. Lives in a header so the clustering
+* code can build on the same engine as the main program.
+*
+* Paul Bupe Jr
+*/
+
+#pragma once
+
+#include "graph.h"
+#include <vector>
+#include <algorithm>
+
+
+// Scratch space for boruvka(). Passing the same workspace to every call keeps its
+// vectors allocated between graphs.
+template <typename V, typename W, typename E = V>
+struct BoruvkaWorkspace
+{
+	std::vector<BasicSet<V>> sets;
+	std::vector<typename EdgeKey<W, E>::type> cheapest_edge;
+};
+
+// The main algorithm
+template <typename V, typename W, typename E>
+void boruvka(AdjList<V, E> &adj_list, std::vector<BasicEdge<V, W>> &edge_list, BoruvkaWorkspace<V, W, E> &ws, BasicMSTResult<E, W> &mst)
+{
+	typedef EdgeKey<W, E> Key;
+
+	V num_v = adj_list.size();
+	V collections = num_v;
+
+	std::vector<BasicSet<V>> &sets = ws.sets;
+	auto &cheapest_edge = ws.cheapest_edge;
+	cheapest_edge.resize(num_v);
+
+	// A spanning tree has exactly V-1 edges, so this is the only allocation for the result
+	mst.cost = 0;
+	mst.edge_ids.clear();
+	mst.edge_ids.reserve(num_v > 0 ? num_v - 1 : 0);
+
+	// Initialize our sets
+	sets.clear();
+	for (V i = 0; i < num_v; i++) { sets.push_back({ i, 0 }); }
+
+	bool merged = true;
+	while (collections > 1 && merged)
+	{
+		// Maintain a list of cheapest edges
+		std::fill(cheapest_edge.begin(), cheapest_edge.end(), Key::none());
+
+		// Calculate the minimum outgoing edge from each set. Keys order edges by weight
+		// and then id, so this is a single integer compare for the packed key types.
+		for (V i = 0; i < num_v; i++)
+		{
+			V src_set = ds_find(sets, i);
+			for (auto const &list : adj_list[i])
+			{
+				if (ds_find(sets, list.first) != src_set) {
+					auto key = Key::make(edge_list[list.second].weight, list.second);
+					if (key < cheapest_edge[src_set]) cheapest_edge[src_set] = key;
+					break;	// Since the adjacency list is sorted, the first valid edge is always the cheapest
+				}
+			}
+		}
+
+		// Using a disjoint set, merge set and populate the MST
+		merged = false;
+		for (V i = 0; i < num_v; i++)
+		{
+			if (cheapest_edge[i] != Key::none())
+			{
+				E id = Key::id(cheapest_edge[i]);
+				const BasicEdge<V, W> &cheapest = edge_list[id];
+
+				V src_set = ds_find(sets, cheapest.src);
+				V dest_set = ds_find(sets, cheapest.dest);
+
+				if (src_set != dest_set) {
+					mst.edge_ids.push_back(id);
+					mst.cost += cheapest.weight;
+					ds_union(sets, src_set, dest_set);
+					collections--;
+					merged = true;
+				}
+			}
+		}
+	}
+}
+
+template <typename V, typename W, typename E>
+BasicMSTResult<E, W> boruvka(AdjList<V, E> &adj_list, std::vector<BasicEdge<V, W>> &edge_list)
+{
+	BoruvkaWorkspace<V, W, E> ws;
+	BasicMSTResult<E, W> mst;
+	boruvka(adj_list, edge_list, ws, mst);
+	return mst;
+}
@@ -0,0 +1,75 @@
+﻿/**
+* Single-linkage k-clustering: MST plus cut
+*
+* Cutting the k-1 heaviest edges out of an MST gives the single-linkage
+* clustering, which is the same as running Kruskal until k components are left.
+*
+* A Boruvka round merges components in no particular weight order, so it cannot
+* simply be stopped at k components. boruvka_clusters() therefore runs the full
+* boruvka() and then makes one O(V) pass over the tree: nth_element() picks the
+* V-k lightest tree edges and only those are unioned in a fresh disjoint set. The
+* labels are read straight off that set. The cost is one MST plus O(V), with no
+* sort of all E edges.
+*
+* Paul Bupe Jr
+*/
+
+#pragma once
+
+#include "graph.h"
+#include "boruvka.h"
+#include <vector>
+#include <algorithm>
+#include <limits>
+
+
+// adj_list and edge_list are the same as for boruvka().
+// Returns a cluster label in 0..k-1 for every vertex. A graph with more than k
+// connected components keeps one label per component.
+template <typename V, typename W, typename E>
+std::vector<V> boruvka_clusters(AdjList<V, E> &adj_list, std::vector<BasicEdge<V, W>> &edge_list, V k)
+{
+	typedef EdgeKey<W, E> Key;
+
+	V num_v = adj_list.size();
+
+	// The minimum spanning forest, from the same engine as the main program
+	BoruvkaWorkspace<V, W, E> ws;
+	BasicMSTResult<E, W> mst;
+	boruvka(adj_list, edge_list, ws, mst);
+
+	// k clusters take the num_v - k lightest tree edges. A forest with more than k
+	// components has fewer edges than that and is kept whole.
+	std::vector<E> &tree = mst.edge_ids;
+	size_t keep = tree.size();
+	if (k >= num_v) keep = 0;
+	else if (size_t(num_v - k) < keep) keep = num_v - k;
+	if (keep < tree.size())
+	{
+		std::nth_element(tree.begin(), tree.begin() + keep, tree.end(), [&](E lhs, E rhs)
+		{return Key::make(edge_list[lhs].weight, lhs) < Key::make(edge_list[rhs].weight, rhs); });
+	}
+
+	// Union only the kept edges in a fresh disjoint set, reusing the workspace's
+	std::vector<BasicSet<V>> &sets = ws.sets;
+	for (V i = 0; i < num_v; i++) { sets[i] = { i, 0 }; }
+	for (size_t i = 0; i < keep; i++)
+	{
+		const BasicEdge<V, W> &e = edge_list[tree[i]];
+		ds_union(sets, e.src, e.dest);
+	}
+
+	// Number the remaining sets densely in order of their first vertex
+	const V no_label = std::numeric_limits<V>::max();
+	std::vector<V> labels(num_v);
+	std::vector<V> set_label(num_v, no_label);
+	V next_label = 0;
+	for (V i = 0; i < num_v; i++)
+	{
+		V root = ds_find(sets, i);
+		if (set_label[root] == no_label) set_label[root] = next_label++;
+		labels[i] = set_label[root];
+	}
+
+	return labels;
+}
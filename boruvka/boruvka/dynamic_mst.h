@@ -0,0 +1,297 @@
+﻿/**
+* Fully dynamic Minimum Spanning Tree (forest)
+*
+* Keeps an MST up to date while edges are inserted, deleted or re-weighted,
+* instead of re-running boruvka() on the whole edge list after every change.
+*
+* Insertion: if the endpoints are in different trees the edge joins the forest.
+* Otherwise the link-cut tree gives us the heaviest edge on the tree path between
+* them; if the new edge is lighter it replaces that edge (cycle property).
+*
+* Deletion: removing a non-tree edge is free. Removing a tree edge splits a tree
+* in two, and the replacement is the lightest edge crossing the cut (cut property).
+* To find it we walk both halves at the same time and stop as soon as one of them
+* is exhausted, then scan the edges incident to that (smaller) half only.
+* This is a heuristic, not Holm et al. or a sqrt decomposition: both walks look at
+* every edge incident to the vertices they visit, tree edge or not, so a deletion
+* costs the degree sum of the smaller half. That is Theta(E) in the worst case
+* (e.g. cutting a dense graph in half), but cheap in practice because most tree
+* edges in an MST hang close to the leaves and cut off only a few vertices.
+*
+* Edges are referred to by the id returned from insert_edge(). The edges given to
+* the constructor get ids 0..E-1 in the order they were passed in. Ids of deleted
+* edges are recycled.
+*
+* Paul Bupe Jr
+*/
+
+#pragma once
+
+#include "graph.h"
+#include "link_cut_tree.h"
+#include <vector>
+#include <algorithm>
+#include <numeric>
+#include <climits>
+#include <cassert>
+
+
+class DynamicMST
+{
+public:
+	// Seed the forest with Kruskal's algorithm over the initial edge list
+	DynamicMST(int num_v, const std::vector<Edge> &edge_list)
+		: num_v(num_v), lct(num_v), incident(num_v), mark(num_v, 0)
+	{
+		for (auto const &e : edge_list) { new_slot(e); }
+
+		std::vector<int> order(slots.size());
+		std::iota(order.begin(), order.end(), 0);
+		std::sort(order.begin(), order.end(), [&](int lhs, int rhs) {return slots[lhs].edge.weight < slots[rhs].edge.weight; });
+
+		std::vector<Set> sets;
+		for (int i = 0; i < num_v; i++) { sets.push_back({ i, 0 }); }
+
+		for (int id : order)
+		{
+			const Edge &e = slots[id].edge;
+			if (ds_find(sets, e.src) != ds_find(sets, e.dest)) {
+				ds_union(sets, e.src, e.dest);
+				link_tree(id);
+			}
+		}
+	}
+
+	int insert_edge(int src, int dest, int weight)
+	{
+		int id = new_slot({ src, dest, weight });
+		offer(id);
+		return id;
+	}
+
+	// id must be a live edge: deleting it twice would corrupt the incidence lists
+	void delete_edge(int id)
+	{
+		assert(id >= 0 && id < (int)slots.size() && slots[id].alive);
+		Slot &s = slots[id];
+		remove_incident(id);
+		s.alive = false;
+		free_ids.push_back(id);
+
+		if (s.in_tree) {
+			cut_tree(id);
+			replace(s.edge.src, s.edge.dest);
+		}
+	}
+
+	void update_weight(int id, int weight)
+	{
+		assert(id >= 0 && id < (int)slots.size() && slots[id].alive);
+		Slot &s = slots[id];
+		int old_weight = s.edge.weight;
+		s.edge.weight = weight;
+
+		if (!s.in_tree) {
+			offer(id);
+		}
+		else if (weight <= old_weight) {
+			// A tree edge getting lighter stays in the tree
+			lct.set_value(num_v + id, weight);
+			path_cost += (long long)weight - old_weight;
+		}
+		else {
+			// A tree edge getting heavier competes with every other edge across its cut
+			s.edge.weight = old_weight;
+			cut_tree(id);
+			s.edge.weight = weight;
+			replace(s.edge.src, s.edge.dest);
+		}
+	}
+
+	long long current_cost() const { return path_cost; }
+
+	int tree_size() const { return tree_count; }
+
+	const Edge &edge(int id) const { return slots[id].edge; }
+
+	std::vector<Edge> tree_edges() const
+	{
+		std::vector<Edge> tree;
+		tree.reserve(tree_count);
+		for (auto const &s : slots)
+		{
+			if (s.alive && s.in_tree) tree.push_back(s.edge);
+		}
+		return tree;
+	}
+
+private:
+	struct Slot
+	{
+		Edge edge;
+		bool alive;
+		bool in_tree;
+		int src_pos, dest_pos;	// Position of this edge in incident[src] / incident[dest]
+	};
+
+	int num_v;
+	int tree_count = 0;
+	long long path_cost = 0;
+
+	// Vertices are nodes 0..V-1 of the link-cut tree, edge id i is node V+i
+	LinkCutTree lct;
+	std::vector<Slot> slots;
+	std::vector<int> free_ids;
+
+	// Every live edge (tree or not) incident to a vertex
+	std::vector<std::vector<int>> incident;
+
+	// Scratch space for the replacement search
+	std::vector<unsigned> mark;
+	unsigned epoch = 0;
+	std::vector<int> side[2];
+
+	int new_slot(const Edge &e)
+	{
+		int id;
+		if (free_ids.empty()) {
+			id = (int)slots.size();
+			slots.push_back({});
+			lct.resize(num_v + id + 1);
+		}
+		else {
+			id = free_ids.back();
+			free_ids.pop_back();
+		}
+
+		Slot &s = slots[id];
+		s.edge = e;
+		s.alive = true;
+		s.in_tree = false;
+		s.src_pos = (int)incident[e.src].size();
+		incident[e.src].push_back(id);
+		s.dest_pos = (int)incident[e.dest].size();
+		incident[e.dest].push_back(id);
+		return id;
+	}
+
+	// Swap-remove an edge from both endpoint lists in O(1)
+	void remove_incident(int id)
+	{
+		const Slot &s = slots[id];
+		remove_at(s.edge.src, s.src_pos);
+		remove_at(s.edge.dest, s.dest_pos);
+	}
+
+	void remove_at(int v, int pos)
+	{
+		std::vector<int> &list = incident[v];
+		int moved = list.back();
+		list[pos] = moved;
+		list.pop_back();
+		if (pos == (int)list.size()) return;
+
+		// For a self loop both positions refer to the same list, so pick the stale one
+		Slot &m = slots[moved];
+		if (m.edge.src == v && m.src_pos == (int)list.size()) m.src_pos = pos;
+		else m.dest_pos = pos;
+	}
+
+	void link_tree(int id)
+	{
+		Slot &s = slots[id];
+		int node = num_v + id;
+		lct.set_value(node, s.edge.weight);
+		lct.link(s.edge.src, node);
+		lct.link(node, s.edge.dest);
+		s.in_tree = true;
+		path_cost += s.edge.weight;
+		tree_count++;
+	}
+
+	void cut_tree(int id)
+	{
+		Slot &s = slots[id];
+		int node = num_v + id;
+		lct.cut(s.edge.src, node);
+		lct.cut(node, s.edge.dest);
+		lct.set_value(node, INT_MIN);
+		s.in_tree = false;
+		path_cost -= s.edge.weight;
+		tree_count--;
+	}
+
+	// Try to put a non-tree edge into the forest
+	void offer(int id)
+	{
+		const Edge &e = slots[id].edge;
+		if (e.src == e.dest) return;
+
+		if (!lct.connected(e.src, e.dest)) {
+			link_tree(id);
+			return;
+		}
+
+		int heaviest = lct.path_max(e.src, e.dest) - num_v;
+		if (slots[heaviest].edge.weight > e.weight) {
+			cut_tree(heaviest);
+			link_tree(id);
+		}
+	}
+
+	// a and b were just separated by removing a tree edge. Reconnect them with the
+	// lightest crossing edge if there is one.
+	void replace(int a, int b)
+	{
+		// Bump the epoch so marks left over from earlier searches are ignored. Once it
+		// is about to wrap, old marks could match the new stamps, so clear them first.
+		if (epoch >= UINT_MAX - 2) {
+			std::fill(mark.begin(), mark.end(), 0u);
+			epoch = 0;
+		}
+		epoch += 2;
+		unsigned stamp[2] = { epoch, epoch + 1 };
+		size_t head[2] = { 0, 0 };
+		side[0].assign(1, a);
+		side[1].assign(1, b);
+		mark[a] = stamp[0];
+		mark[b] = stamp[1];
+
+		// Breadth first over tree edges, one vertex from each half in turn
+		int done = -1;
+		while (done == -1)
+		{
+			for (int k = 0; k < 2 && done == -1; k++)
+			{
+				if (head[k] == side[k].size()) { done = k; break; }
+				int v = side[k][head[k]++];
+				for (int id : incident[v])
+				{
+					if (!slots[id].in_tree) continue;
+					const Edge &e = slots[id].edge;
+					int w = (e.src == v) ? e.dest : e.src;
+					if (mark[w] != stamp[k]) {
+						mark[w] = stamp[k];
+						side[k].push_back(w);
+					}
+				}
+			}
+		}
+
+		// Every edge leaving the finished half crosses the cut
+		int best = -1;
+		for (int v : side[done])
+		{
+			for (int id : incident[v])
+			{
+				const Slot &s = slots[id];
+				if (s.in_tree) continue;
+				int w = (s.edge.src == v) ? s.edge.dest : s.edge.src;
+				if (mark[w] == stamp[done]) continue;
+				if (best == -1 || s.edge.weight < slots[best].edge.weight) best = id;
+			}
+		}
+
+		if (best != -1) link_tree(best);
+	}
+};
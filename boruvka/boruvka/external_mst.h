@@ -0,0 +1,189 @@
+﻿/**
+* Semi-external Boruvka for edge lists that do not fit in memory
+*
+* Only per-vertex state lives in RAM: the disjoint set and one "cheapest edge"
+* slot per vertex, so memory is O(V). The edges stay on disk in a flat binary file
+* of Edge records (see pack_edge_file()) and each Boruvka round is one sequential
+* pass over that file.
+*
+* The pass does two jobs at once. Every edge whose endpoints are already in the
+* same component is dropped, and every other edge is copied to a scratch file and
+* offered as the cheapest edge for both of its components. The next round reads the
+* scratch file, so the file shrinks as components merge. There are at most log2(V)
+* rounds, which gives O(E log V) bytes of sequential I/O.
+*
+* Ties between equal weights are broken by lighter_edge() so that every component
+* agrees on the order of edges and no cycles can be formed.
+*
+* Paul Bupe Jr
+*/
+
+#pragma once
+
+#include "graph.h"
+#include <string>
+#include <vector>
+#include <fstream>
+#include <cstdio>
+#include <algorithm>
+#include <utility>
+
+
+// Number of edges read or written per I/O call
+const size_t EXTERNAL_CHUNK = 1 << 16;
+
+// Convert a CSV edge file (src,dest,weight per line) into the binary format used
+// by semi_external_boruvka(). Streams the input so it works on any file size.
+// Returns the number of vertices (largest id + 1), or -1 on an I/O error, a line
+// that is not an edge or a negative vertex id.
+inline int pack_edge_file(const std::string &csv_path, const std::string &bin_path)
+{
+	std::ifstream in(csv_path);
+	std::ofstream out(bin_path, std::ios::binary | std::ios::trunc);
+	if (!in || !out) return -1;
+
+	std::vector<Edge> chunk;
+	chunk.reserve(EXTERNAL_CHUNK);
+	int max_id = -1;
+	Edge e;
+
+	while (in >> e)
+	{
+		if (e.src < 0 || e.dest < 0) return -1;
+		max_id = std::max(max_id, std::max(e.src, e.dest));
+		chunk.push_back(e);
+		if (chunk.size() == EXTERNAL_CHUNK) {
+			out.write(reinterpret_cast<const char *>(chunk.data()), chunk.size() * sizeof(Edge));
+			chunk.clear();
+		}
+	}
+	out.write(reinterpret_cast<const char *>(chunk.data()), chunk.size() * sizeof(Edge));
+
+	// Reading stops at the first line that does not parse, which must be the end of the file
+	in >> std::ws;
+	return (out && in.eof()) ? max_id + 1 : -1;
+}
+
+// One pass to find the number of vertices of a binary edge file. Returns -1 if the
+// file cannot be read, ends in a partial record or holds a negative vertex id.
+inline int count_vertices(const std::string &bin_path)
+{
+	std::ifstream in(bin_path, std::ios::binary);
+	if (!in) return -1;
+
+	std::vector<Edge> chunk(EXTERNAL_CHUNK);
+	int max_id = -1;
+	while (in.read(reinterpret_cast<char *>(chunk.data()), chunk.size() * sizeof(Edge)) || in.gcount() > 0)
+	{
+		if (in.gcount() % sizeof(Edge) != 0) return -1;
+		size_t n = (size_t)in.gcount() / sizeof(Edge);
+		for (size_t i = 0; i < n; i++)
+		{
+			if (chunk[i].src < 0 || chunk[i].dest < 0) return -1;
+			max_id = std::max(max_id, std::max(chunk[i].src, chunk[i].dest));
+		}
+	}
+	return in.bad() ? -1 : max_id + 1;
+}
+
+// Computes the minimum spanning forest of the graph stored in bin_path. The input file
+// is never modified; scratch_path and scratch_path + ".1" hold the filtered edges and
+// are removed afterwards. Tree edges are appended to mst_edges and their total weight
+// is stored in path_cost. Returns false if a file could not be read or written, ends
+// in a partial record, or holds a vertex id outside 0..num_v-1.
+inline bool semi_external_boruvka(const std::string &bin_path, int num_v, const std::string &scratch_path, std::vector<Edge> &mst_edges, long long &path_cost)
+{
+	const std::string scratch[2] = { scratch_path, scratch_path + ".1" };
+	const Edge no_edge = { -1, -1, -1 };
+
+	std::vector<Set> sets;
+	std::vector<Edge> cheapest_edge(num_v, no_edge);
+	std::vector<Edge> read_buf(EXTERNAL_CHUNK);
+	std::vector<Edge> write_buf;
+	write_buf.reserve(EXTERNAL_CHUNK);
+
+	for (int i = 0; i < num_v; i++) { sets.push_back({ i, 0 }); }
+	mst_edges.reserve(mst_edges.size() + std::max(num_v - 1, 0));
+
+	path_cost = 0;
+	std::string source = bin_path;
+	int round = 0;
+	bool merged = true;
+
+	while (merged)
+	{
+		std::ifstream in(source, std::ios::binary);
+		std::ofstream out(scratch[round % 2], std::ios::binary | std::ios::trunc);
+		if (!in || !out) {
+			in.close();
+			out.close();
+			std::remove(scratch[0].c_str());
+			std::remove(scratch[1].c_str());
+			return false;
+		}
+
+		// Filter out intra-component edges and find the cheapest outgoing edge of each set
+		bool corrupt = false;
+		while (!corrupt && (in.read(reinterpret_cast<char *>(read_buf.data()), read_buf.size() * sizeof(Edge)) || in.gcount() > 0))
+		{
+			corrupt = (in.gcount() % sizeof(Edge) != 0);
+			size_t n = corrupt ? 0 : (size_t)in.gcount() / sizeof(Edge);
+			for (size_t i = 0; i < n; i++)
+			{
+				const Edge &e = read_buf[i];
+				if (e.src < 0 || e.src >= num_v || e.dest < 0 || e.dest >= num_v) {
+					corrupt = true;
+					break;
+				}
+				int src_set = ds_find(sets, e.src);
+				int dest_set = ds_find(sets, e.dest);
+				if (src_set == dest_set) continue;
+
+				write_buf.push_back(e);
+				if (write_buf.size() == write_buf.capacity()) {
+					out.write(reinterpret_cast<const char *>(write_buf.data()), write_buf.size() * sizeof(Edge));
+					write_buf.clear();
+				}
+
+				if (cheapest_edge[src_set].src == -1 || lighter_edge(e, cheapest_edge[src_set])) cheapest_edge[src_set] = e;
+				if (cheapest_edge[dest_set].src == -1 || lighter_edge(e, cheapest_edge[dest_set])) cheapest_edge[dest_set] = e;
+			}
+		}
+		out.write(reinterpret_cast<const char *>(write_buf.data()), write_buf.size() * sizeof(Edge));
+		write_buf.clear();
+		if (corrupt || !out || in.bad()) {
+			in.close();
+			out.close();
+			std::remove(scratch[0].c_str());
+			std::remove(scratch[1].c_str());
+			return false;
+		}
+
+		// Using a disjoint set, merge set and populate the MST
+		merged = false;
+		for (int i = 0; i < num_v; i++)
+		{
+			Edge cheapest = cheapest_edge[i];
+			if (cheapest.src == -1) continue;
+			cheapest_edge[i] = no_edge;
+
+			int src_set = ds_find(sets, cheapest.src);
+			int dest_set = ds_find(sets, cheapest.dest);
+
+			if (src_set != dest_set) {
+				mst_edges.push_back(cheapest);
+				path_cost += cheapest.weight;
+				ds_union(sets, src_set, dest_set);
+				merged = true;
+			}
+		}
+
+		source = scratch[round % 2];
+		round++;
+	}
+
+	std::remove(scratch[0].c_str());
+	std::remove(scratch[1].c_str());
+
+	return true;
+}
@@ -0,0 +1,277 @@
+﻿/**
+* Shared graph types for the MST programs
+*
+* The weighted edge and the disjoint set (union-find) live here so that
+* boruvka() and the dynamic MST can work on the same representation.
+*
+* Everything is templated on the vertex id type V, the weight type W and the edge
+* id type E, so a graph can use float/double weights, unsigned 32 bit ids, or 64
+* bit ids for more than 2^32 vertices or edges. E defaults to V but can be wider,
+* since a graph usually has many more edges than vertices.
+* Edge, Set and MSTResult are the plain int versions used by the rest of the code.
+*
+* Sizes (x64): an adjacency entry is a vertex id and an edge id, 8 bytes for 32 bit
+* ids and 16 for 64 bit ids. An edge record is rounded up to the alignment of V, so
+* BasicEdge<uint32_t, uint16_t> is 12 bytes like BasicEdge<int, int>; narrow weights
+* only shrink it together with narrow vertex ids (BasicEdge<uint16_t, uint16_t> is 6).
+*
+* Paul Bupe Jr
+*/
+
+#pragma once
+
+#include <iostream>
+#include <vector>
+#include <algorithm>
+#include <utility>
+#include <limits>
+#include <type_traits>
+#include <cstdint>
+#include <cstring>
+#include <cstdlib>
+#include <cerrno>
+#include <cmath>
+
+
+// Representation of a weighted edge
+template <typename V, typename W>
+struct BasicEdge
+{
+	V src, dest;
+	W weight;
+
+	// Overload the >> operator to make parsing the input file cleaner
+	friend std::istream& operator >>(std::istream& is, BasicEdge& v)
+	{
+		char ch;
+		is >> v.src >> ch >> v.dest >> ch >> v.weight;
+		return is;
+	}
+};
+
+typedef BasicEdge<int, int> Edge;
+
+
+// Parses one "src,dest,weight" line and moves p past it. Unlike operator >> this
+// checks every field: returns false if a field is missing or not a number, a vertex
+// id is negative or not below max_id, or the weight does not fit W (e.g. a weight
+// over 65535 for uint16_t weights). The field separators may be padded with blanks.
+template <typename V, typename W>
+bool parse_edge_line(const char *&p, BasicEdge<V, W> &e, unsigned long long max_id)
+{
+	auto skip_blanks = [&p]() { while (*p == ' ' || *p == '\t') p++; };
+	char *end;
+
+	unsigned long long ids[2];
+	for (int f = 0; f < 2; f++)
+	{
+		skip_blanks();
+		errno = 0;
+		long long id = std::strtoll(p, &end, 10);
+		if (end == p || errno == ERANGE || id < 0 || (unsigned long long)id >= max_id) return false;
+		ids[f] = (unsigned long long)id;
+		p = end;
+		skip_blanks();
+		if (*p != ',') return false;
+		p++;
+	}
+
+	skip_blanks();
+	errno = 0;
+	if (std::is_floating_point<W>::value) {
+		double w = std::strtod(p, &end);
+		if (end == p || !std::isfinite(w) || std::fabs(w) > (double)std::numeric_limits<W>::max()) return false;
+		e.weight = W(w);
+	}
+	else {
+		long long w = std::strtoll(p, &end, 10);
+		if (end == p || errno == ERANGE) return false;
+		if (w < (long long)std::numeric_limits<W>::lowest() || w > (long long)std::numeric_limits<W>::max()) return false;
+		e.weight = W(w);
+	}
+	p = end;
+
+	while (*p == ' ' || *p == '\t' || *p == '\r') p++;
+	if (*p == '\n') p++;
+	else if (*p != '\0') return false;
+
+	e.src = V(ids[0]);
+	e.dest = V(ids[1]);
+	return true;
+}
+
+
+// Order preserving map from a weight onto an unsigned integer of the same size, so
+// that comparing the bits compares the weights. Signed integers get their sign bit
+// flipped, IEEE floats additionally get their magnitude bits flipped when negative.
+template <typename W>
+struct WeightBits
+{
+	typedef typename std::make_unsigned<W>::type type;
+	static type get(W w)
+	{
+		const type sign = std::is_signed<W>::value ? type(type(1) << (sizeof(W) * 8 - 1)) : type(0);
+		return type(type(w) ^ sign);
+	}
+};
+
+template <>
+struct WeightBits<float>
+{
+	typedef uint32_t type;
+	static type get(float w)
+	{
+		type b;
+		std::memcpy(&b, &w, sizeof(b));
+		return (b & 0x80000000u) ? ~b : (b | 0x80000000u);
+	}
+};
+
+template <>
+struct WeightBits<double>
+{
+	typedef uint64_t type;
+	static type get(double w)
+	{
+		type b;
+		std::memcpy(&b, &w, sizeof(b));
+		return (b & 0x8000000000000000ull) ? ~b : (b | 0x8000000000000000ull);
+	}
+};
+
+
+// Sort key of an edge: its weight with the edge id as a tie breaker. Because ids are
+// unique every component agrees on which of two equal weights is cheaper, which
+// Boruvka needs to avoid closing a cycle, and the id comes straight out of the key.
+// When both the weight and the id fit in 32 bits the key is packed into a single
+// 64 bit integer so the hot comparison loop is one integer compare.
+template <typename W, typename E, bool Packed = (sizeof(W) <= 4 && sizeof(E) <= 4)>
+struct EdgeKey
+{
+	typedef uint64_t type;
+	static type make(W weight, E id) { return (type(WeightBits<W>::get(weight)) << 32) | uint32_t(id); }
+	static E id(type key) { return E(uint32_t(key)); }
+	static type none() { return std::numeric_limits<type>::max(); }
+};
+
+template <typename W, typename E>
+struct EdgeKey<W, E, false>
+{
+	typedef std::pair<typename WeightBits<W>::type, E> type;
+	static type make(W weight, E id) { return type(WeightBits<W>::get(weight), id); }
+	static E id(const type &key) { return key.second; }
+	static type none() { return type(std::numeric_limits<typename type::first_type>::max(), std::numeric_limits<E>::max()); }
+};
+
+
+// Adjacency list: for every vertex its neighbours with the id (index into the edge
+// list) of the connecting edge, sorted by edge key so the first edge leaving a
+// component is always the cheapest. Weights are read from the edge list, which
+// keeps an entry down to two ids.
+template <typename V, typename E = V>
+using AdjList = std::vector<std::vector<std::pair<V, E>>>;
+
+// Builds the adjacency list of an undirected edge list. Existing vectors are cleared
+// rather than freed so a list can be reused across graphs without reallocating.
+// Returns false if the edge list has more edges than E can number; the largest
+// value of E is kept free as the "no edge" key.
+template <typename V, typename W, typename E>
+bool build_adj_list(AdjList<V, E> &adj_list, V num_v, const std::vector<BasicEdge<V, W>> &edge_list)
+{
+	typedef EdgeKey<W, E> Key;
+
+	if (edge_list.size() > (unsigned long long)std::numeric_limits<E>::max()) return false;
+
+	adj_list.resize(num_v);
+	for (auto &list : adj_list) { list.clear(); }
+
+	for (size_t id = 0; id < edge_list.size(); id++)
+	{
+		const BasicEdge<V, W> &e = edge_list[id];
+		adj_list[e.src].push_back(std::make_pair(e.dest, E(id)));
+		if (e.src != e.dest) adj_list[e.dest].push_back(std::make_pair(e.src, E(id)));
+	}
+
+	for (auto &list : adj_list)
+	{
+		std::sort(list.begin(), list.end(), [&](const auto& lhs, const auto& rhs)
+		{return Key::make(edge_list[lhs.second].weight, lhs.second) < Key::make(edge_list[rhs.second].weight, rhs.second); });
+	}
+	return true;
+}
+
+
+// Flat MST result: the total cost and the ids (indices into the edge list) of the
+// tree edges. Integer costs are 64 bit since summing V-1 weights can overflow.
+template <typename E, typename W>
+struct BasicMSTResult
+{
+	typedef typename std::conditional<std::is_floating_point<W>::value, double, long long>::type cost_type;
+
+	cost_type cost;
+	std::vector<E> edge_ids;
+};
+
+typedef BasicMSTResult<int, int> MSTResult;
+
+
+// Strict order on edges: weight first, then the unordered vertex pair.
+// Used where edges have no ids, e.g. when they are streamed from a file.
+template <typename V, typename W>
+inline bool lighter_edge(const BasicEdge<V, W> &lhs, const BasicEdge<V, W> &rhs)
+{
+	V l_lo = std::min(lhs.src, lhs.dest), l_hi = std::max(lhs.src, lhs.dest);
+	V r_lo = std::min(rhs.src, rhs.dest), r_hi = std::max(rhs.src, rhs.dest);
+	if (lhs.weight != rhs.weight) return lhs.weight < rhs.weight;
+	if (l_lo != r_lo) return l_lo < r_lo;
+	return l_hi < r_hi;
+}
+
+
+// Utilizing disjoint sets to handle the merging of all the sets (collections) we create
+// This requires find() and union() methods for identifying which set an edge belongs to
+// and for merging sets.
+
+template <typename V>
+struct BasicSet
+{
+	V parent;
+	int rank;
+};
+
+typedef BasicSet<int> Set;
+
+template <typename V, typename I>
+inline V ds_find(std::vector<BasicSet<V>> &sets, I i)
+{
+	// Find root and make root as parent of i
+	if (sets[i].parent != V(i)) sets[i].parent = ds_find(sets, sets[i].parent);
+	return sets[i].parent;
+}
+
+// This function is a third party implementation of union by rank
+// Nothing special going on here.
+// https://www.geeksforgeeks.org/union-find-algorithm-set-2-union-by-rank/
+
+template <typename V, typename I>
+inline void ds_union(std::vector<BasicSet<V>> &sets, I x, I y)
+{
+	V xroot = ds_find(sets, x);
+	V yroot = ds_find(sets, y);
+
+	// Attach smaller rank tree under root of higher rank tree
+	if (sets[xroot].rank < sets[yroot].rank)
+	{
+		sets[xroot].parent = yroot;
+	}
+	else if (sets[xroot].rank > sets[yroot].rank)
+	{
+			sets[yroot].parent = xroot;
+	}
+	// If ranks are same, then make one as root and increment its rank by one
+	else
+	{
+		sets[yroot].parent = xroot;
+		sets[xroot].rank++;
+	}
+}
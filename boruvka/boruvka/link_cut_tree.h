@@ -0,0 +1,195 @@
+﻿/**
+* Link-Cut Tree (Sleator & Tarjan)
+*
+* Maintains a forest of rooted trees under link and cut, and answers
+* "which node on the path u..v has the largest value" in O(log n) amortized.
+* Each preferred path is stored as a splay tree keyed by depth, and every
+* splay node caches the index of the maximum valued node in its subtree.
+*
+* The dynamic MST stores every tree edge as its own node sitting between its
+* two endpoints, so a path-max query returns the heaviest edge on the path.
+*
+* Paul Bupe Jr
+*/
+
+#pragma once
+
+#include <vector>
+#include <climits>
+#include <utility>
+
+
+class LinkCutTree
+{
+public:
+	explicit LinkCutTree(int n = 0) { resize(n); }
+
+	int size() const { return (int)nodes.size(); }
+
+	// New nodes start out as isolated single node trees with the lowest value
+	void resize(int n)
+	{
+		int old = (int)nodes.size();
+		nodes.resize(n);
+		for (int i = old; i < n; i++) { nodes[i] = { { -1, -1 }, -1, INT_MIN, i, false }; }
+	}
+
+	// Change the value of a node. The node is splayed to the top of its path first
+	// so only its own cached maximum needs fixing.
+	void set_value(int x, int value)
+	{
+		access(x);
+		nodes[x].value = value;
+		pull(x);
+	}
+
+	int value(int x) const { return nodes[x].value; }
+
+	// Makes x the root of its tree by reversing the path from the old root to x
+	void make_root(int x)
+	{
+		access(x);
+		nodes[x].flip = !nodes[x].flip;
+	}
+
+	int find_root(int x)
+	{
+		access(x);
+		while (true)
+		{
+			push(x);
+			if (nodes[x].ch[0] == -1) break;
+			x = nodes[x].ch[0];
+		}
+		splay(x);
+		return x;
+	}
+
+	bool connected(int u, int v)
+	{
+		return u == v || find_root(u) == find_root(v);
+	}
+
+	// Caller must make sure u and v are in different trees
+	void link(int u, int v)
+	{
+		make_root(u);
+		nodes[u].parent = v;
+	}
+
+	// Caller must make sure (u, v) is an edge of the forest
+	void cut(int u, int v)
+	{
+		make_root(u);
+		access(v);
+		// u is now the only node above v on the path, i.e. the left child of v
+		nodes[v].ch[0] = -1;
+		nodes[u].parent = -1;
+		pull(v);
+	}
+
+	// Returns the node holding the maximum value on the path between u and v.
+	// Both nodes must be in the same tree.
+	int path_max(int u, int v)
+	{
+		make_root(u);
+		access(v);
+		return nodes[v].max_node;
+	}
+
+private:
+	struct Node
+	{
+		int ch[2];		// Left/right children in the splay tree
+		int parent;		// Splay parent, or path-parent pointer when x is a splay root
+		int value;
+		int max_node;	// Index of the maximum valued node in this splay subtree
+		bool flip;		// Lazy reversal flag
+	};
+
+	std::vector<Node> nodes;
+	std::vector<int> splay_stack;
+
+	bool is_splay_root(int x) const
+	{
+		int p = nodes[x].parent;
+		return p == -1 || (nodes[p].ch[0] != x && nodes[p].ch[1] != x);
+	}
+
+	void push(int x)
+	{
+		Node &n = nodes[x];
+		if (!n.flip) return;
+		std::swap(n.ch[0], n.ch[1]);
+		if (n.ch[0] != -1) nodes[n.ch[0]].flip = !nodes[n.ch[0]].flip;
+		if (n.ch[1] != -1) nodes[n.ch[1]].flip = !nodes[n.ch[1]].flip;
+		n.flip = false;
+	}
+
+	void pull(int x)
+	{
+		Node &n = nodes[x];
+		n.max_node = x;
+		for (int c : n.ch)
+		{
+			if (c != -1 && nodes[nodes[c].max_node].value > nodes[n.max_node].value) n.max_node = nodes[c].max_node;
+		}
+	}
+
+	void rotate(int x)
+	{
+		int p = nodes[x].parent;
+		int g = nodes[p].parent;
+		int dir = (nodes[p].ch[1] == x) ? 1 : 0;
+		int b = nodes[x].ch[dir ^ 1];
+
+		// Hook x into the grandparent, keeping path-parent pointers intact
+		if (!is_splay_root(p)) nodes[g].ch[(nodes[g].ch[1] == p) ? 1 : 0] = x;
+		nodes[x].parent = g;
+
+		nodes[x].ch[dir ^ 1] = p;
+		nodes[p].parent = x;
+
+		nodes[p].ch[dir] = b;
+		if (b != -1) nodes[b].parent = p;
+
+		pull(p);
+		pull(x);
+	}
+
+	void splay(int x)
+	{
+		// Push pending reversals top down before rotating
+		splay_stack.clear();
+		int y = x;
+		splay_stack.push_back(y);
+		while (!is_splay_root(y)) { y = nodes[y].parent; splay_stack.push_back(y); }
+		for (auto it = splay_stack.rbegin(); it != splay_stack.rend(); ++it) push(*it);
+
+		while (!is_splay_root(x))
+		{
+			int p = nodes[x].parent;
+			if (!is_splay_root(p))
+			{
+				int g = nodes[p].parent;
+				bool zigzig = (nodes[g].ch[0] == p) == (nodes[p].ch[0] == x);
+				rotate(zigzig ? p : x);
+			}
+			rotate(x);
+		}
+	}
+
+	// Makes the root to x path preferred and leaves x at the root of its splay tree
+	void access(int x)
+	{
+		int last = -1;
+		for (int y = x; y != -1; y = nodes[y].parent)
+		{
+			splay(y);
+			nodes[y].ch[1] = last;
+			pull(y);
+			last = y;
+		}
+		splay(x);
+	}
+};
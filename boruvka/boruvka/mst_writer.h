@@ -0,0 +1,153 @@
+﻿/**
+* Buffered output for MST results
+*
+* Printing a large tree through std::cout one edge at a time spends most of its
+* time in iostream formatting and flushing. MSTWriter formats into one large
+* buffer by hand and hands it to fwrite() only when the buffer is full. When it
+* writes to a string instead, the string itself is the buffer.
+*
+* Two formats are supported:
+*   text   - the same "Total path cost is: ..." / "{src,dest} " output as before
+*   binary - a 4 byte header (id size, id kind, weight size, weight kind, where
+*            a kind is 'i' signed, 'u' unsigned or 'f' floating point), the cost
+*            (int64, or double for floating point weights), int64 edge count, then
+*            src, dest and weight of each edge packed with no padding. All values
+*            are in host byte order. The file must be opened with "wb" so no
+*            newline translation takes place.
+*
+* Paul Bupe Jr
+*/
+
+#pragma once
+
+#include "graph.h"
+#include <cstdio>
+#include <cstring>
+#include <vector>
+#include <string>
+#include <type_traits>
+
+
+class MSTWriter
+{
+public:
+	MSTWriter(std::FILE *out, bool binary = false)
+		: out(out), sink(nullptr), binary(binary), buf(1 << 20), used(0) {}
+
+	// Append text output to a string instead of a file, e.g. to collect one result
+	// per job in batch mode
+	explicit MSTWriter(std::string &sink)
+		: out(nullptr), sink(&sink), binary(false), used(0) {}
+
+	~MSTWriter() { flush(); }
+
+	// V and W are the id and weight types of the edges that follow
+	template <typename V, typename W, typename C>
+	void begin(C cost, long long num_edges)
+	{
+		if (binary) {
+			const char header[4] = { char(sizeof(V)), type_kind<V>(), char(sizeof(W)), type_kind<W>() };
+			put(header, sizeof(header));
+			put(reinterpret_cast<const char *>(&cost), sizeof(cost));
+			put(reinterpret_cast<const char *>(&num_edges), sizeof(num_edges));
+			return;
+		}
+		put_str("Total path cost is: ");
+		put_num(cost);
+		put_str("\nMST is: ");
+	}
+
+	template <typename V, typename W>
+	void edge(const BasicEdge<V, W> &e)
+	{
+		if (binary) {
+			put(reinterpret_cast<const char *>(&e.src), sizeof(e.src));
+			put(reinterpret_cast<const char *>(&e.dest), sizeof(e.dest));
+			put(reinterpret_cast<const char *>(&e.weight), sizeof(e.weight));
+			return;
+		}
+		put_char('{');
+		put_num(e.src);
+		put_char(',');
+		put_num(e.dest);
+		put_str("} ");
+	}
+
+	void end()
+	{
+		if (!binary) put_char('\n');
+		flush();
+	}
+
+	void flush()
+	{
+		drain();
+		if (out) std::fflush(out);
+	}
+
+private:
+	std::FILE *out;
+	std::string *sink;
+	bool binary;
+	std::vector<char> buf;
+	size_t used;
+
+	void drain()
+	{
+		if (used == 0) return;
+		std::fwrite(buf.data(), 1, used, out);
+		used = 0;
+	}
+
+	void put(const char *data, size_t n)
+	{
+		if (sink) {
+			sink->append(data, n);
+			return;
+		}
+		if (used + n > buf.size()) drain();
+		std::memcpy(buf.data() + used, data, n);
+		used += n;
+	}
+
+	void put_char(char c)
+	{
+		if (sink) {
+			sink->push_back(c);
+			return;
+		}
+		if (used == buf.size()) drain();
+		buf[used++] = c;
+	}
+
+	void put_str(const char *s) { put(s, std::strlen(s)); }
+
+	template <typename T>
+	static char type_kind()
+	{
+		return std::is_floating_point<T>::value ? 'f' : (std::is_signed<T>::value ? 'i' : 'u');
+	}
+
+	// Integers are formatted back to front into a small scratch array. Floating point
+	// costs are rare enough to go through snprintf.
+	template <typename T>
+	void put_num(T value)
+	{
+		char digits[32];
+		if (std::is_floating_point<T>::value) {
+			int n = std::snprintf(digits, sizeof(digits), "%g", double(value));
+			put(digits, n);
+			return;
+		}
+
+		bool negative = std::is_signed<T>::value && value < T(0);
+		unsigned long long v = negative ? 0ULL - (unsigned long long)(long long)value : (unsigned long long)value;
+		int pos = sizeof(digits);
+		do {
+			digits[--pos] = char('0' + v % 10);
+			v /= 10;
+		} while (v > 0);
+		if (negative) digits[--pos] = '-';
+		put(digits + pos, sizeof(digits) - pos);
+	}
+};
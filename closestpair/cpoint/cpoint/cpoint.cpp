@@ -10,6 +10,12 @@
 * which I didn't optimize. There are also a few other places where I should have been
 * passing pointers instead of manipulating data.
 *
+* Running with --batch [threads] solves a stream of point sets read from stdin on
+* a thread pool (see common/batch_runner.h for the job format).
+*
+* --lsh-bench [n] [dim] benchmarks the approximate high dimensional closest pair
+* (lsh_pair.h) and measures its recall against brute force.
+*
 * Paul Bupe Jr
 */
 
@@ -21,6 +27,12 @@
 #include <fstream>
 #include <iterator>
 #include <math.h>
+#include <cstdio>
+#include <cstdlib>
+#include <chrono>
+#include <random>
+#include "../../../common/batch_runner.h"
+#include "lsh_pair.h"
 
 // Input file. Expects a single comma separated point per line
 std::ifstream input("points2d.txt");
@@ -172,8 +184,157 @@ std::pair<Point, Point> find_closest_pair(std::vector<Point> &points, std::vecto
 	// Time to iterate through our 
 }
 
-int main()
+// Buffers for one --batch worker, reused for every job it solves. Only the top level
+// vectors are covered: find_closest_pair() still allocates its six halves and strip
+// vectors at every level of the recursion.
+struct BatchWorkspace
+{
+	std::vector<Point> points;
+	std::vector<Point> points_sorted_x;
+	std::vector<Point> points_sorted_y;
+};
+
+// Solves one --batch job: the lines of a points csv file
+void solve_batch_job(BatchWorkspace &ws, const std::string &job, std::string &result)
+{
+	// Parse "x,y" lines without going through a stringstream
+	ws.points.clear();
+	const char *p = job.c_str();
+	for (int line = 1; *p != '\0'; line++)
+	{
+		while (*p == ' ' || *p == '\t' || *p == '\r') p++;
+		if (*p == '\n') { p++; continue; }
+		if (*p == '\0') break;
+
+		char *end;
+		Point point;
+		point.x = std::strtod(p, &end);
+		bool ok = (end != p);
+		p = end;
+		while (*p == ' ' || *p == '\t') p++;
+		ok = ok && (*p == ',');
+		if (ok) {
+			p++;
+			point.y = std::strtod(p, &end);
+			ok = (end != p) && std::isfinite(point.x) && std::isfinite(point.y);
+			p = end;
+		}
+		while (*p == ' ' || *p == '\t' || *p == '\r') p++;
+		if (!ok || (*p != '\n' && *p != '\0'))
+		{
+			result += "Error: bad point on line " + std::to_string(line) + "\n";
+			return;
+		}
+		if (*p == '\n') p++;
+
+		point.z = 0;
+		ws.points.push_back(point);
+	}
+
+	// Nothing to pair up
+	if (ws.points.size() < 2)
+	{
+		result += "()\n";
+		return;
+	}
+
+	ws.points_sorted_x.assign(ws.points.begin(), ws.points.end());
+	ws.points_sorted_y.assign(ws.points.begin(), ws.points.end());
+	std::sort(ws.points_sorted_x.begin(), ws.points_sorted_x.end(), [](const auto& lhs, const auto& rhs) {return lhs.x < rhs.x; });
+	std::sort(ws.points_sorted_y.begin(), ws.points_sorted_y.end(), [](const auto& lhs, const auto& rhs) {return lhs.y < rhs.y; });
+
+	auto final_pair = find_closest_pair(ws.points, ws.points_sorted_x, ws.points_sorted_y);
+
+	// Same format as the single file output, %g matches std::cout's default precision
+	char line[128];
+	int n = std::snprintf(line, sizeof(line), "(%g,%g)(%g,%g)\n",
+		final_pair.first.x, final_pair.first.y, final_pair.second.x, final_pair.second.y);
+	result.append(line, n);
+}
+
+// Benchmark for the LSH closest pair (run as: cpoint --lsh-bench [n] [dim])
+// Makes n random vectors with lengths between 0.5 and 2, a tenth of which are noisy
+// copies of other vectors (the near-duplicates we want to find), then compares a few
+// LSH settings against the exact brute force answer. Recall is the fraction of the
+// exact pairs within the near-duplicate radius that LSH also found.
+int lsh_benchmark(int n, int dim)
 {
+	typedef std::chrono::steady_clock clock;
+	const double radius = 0.5;
+
+	std::mt19937 rng(7432);
+	std::normal_distribution<float> gauss(0.0f, 1.0f);
+	std::uniform_real_distribution<float> length(0.5f, 2.0f);
+	std::uniform_real_distribution<float> noise_level(0.02f, 0.4f);
+
+	// A Gaussian vector scaled by 1/sqrt(dim) has a length of about 1
+	const float unit = 1.0f / std::sqrt((float)dim);
+	std::vector<float> data((size_t)n * dim);
+	for (int i = 0; i < n; i++)
+	{
+		float *v = &data[(size_t)i * dim];
+		if (i >= n - n / 10 && i > 0) {
+			const float *base = &data[(size_t)(rng() % i) * dim];
+			float sigma = noise_level(rng) * unit;
+			for (int k = 0; k < dim; k++) { v[k] = base[k] + sigma * gauss(rng); }
+		}
+		else {
+			float scale = length(rng) * unit;
+			for (int k = 0; k < dim; k++) { v[k] = scale * gauss(rng); }
+		}
+	}
+
+	auto start = clock::now();
+	VectorPair exact = brute_force_pair_nd(data, dim);
+	double exact_time = std::chrono::duration<double>(clock::now() - start).count();
+	std::vector<VectorPair> exact_near = brute_force_near_pairs(data, dim, radius);
+
+	std::printf("%d vectors, %d dimensions, %d pairs within %g\n", n, dim, (int)exact_near.size(), radius);
+	std::printf("Brute force: %.1f ms, closest pair (%d,%d) at %g\n\n", exact_time * 1000, exact.first, exact.second, exact.dist);
+	std::printf("tables hashes probes   time(ms)  speedup  closest  recall\n");
+
+	// Bucket width a few times the radius: near pairs mostly share a slot, random pairs rarely do
+	const int settings[][3] = { { 1, 12, 0 }, { 4, 12, 0 }, { 4, 12, 4 }, { 8, 12, 4 }, { 16, 12, 8 } };
+	for (auto const &setting : settings)
+	{
+		LSHParams params;
+		params.num_tables = setting[0];
+		params.num_hashes = setting[1];
+		params.num_probes = setting[2];
+		params.bucket_width = float(4 * radius);
+
+		start = clock::now();
+		LSHIndex index(data, dim, params);
+		VectorPair found = index.closest_pair();
+		double lsh_time = std::chrono::duration<double>(clock::now() - start).count();
+
+		std::vector<VectorPair> found_near = index.near_pairs(radius);
+		double recall = exact_near.empty() ? 1.0 : (double)found_near.size() / exact_near.size();
+
+		std::printf("%6d %6d %6d %10.1f %8.1fx %8s %6.1f%%\n", params.num_tables, params.num_hashes, params.num_probes,
+			lsh_time * 1000, exact_time / lsh_time, (found.dist == exact.dist) ? "yes" : "no", recall * 100);
+	}
+
+	return 0;
+}
+
+int main(int argc, char *argv[])
+{
+	if (argc > 1 && std::string(argv[1]) == "--lsh-bench")
+	{
+		int n = (argc > 2) ? std::atoi(argv[2]) : 10000;
+		int dim = (argc > 3) ? std::atoi(argv[3]) : 128;
+		return lsh_benchmark(n, dim);
+	}
+
+	if (argc > 1 && std::string(argv[1]) == "--batch")
+	{
+		std::ios::sync_with_stdio(false);
+		unsigned num_threads = (argc > 2) ? std::atoi(argv[2]) : 0;
+		run_batch<BatchWorkspace>(std::cin, stdout, solve_batch_job, num_threads);
+		return 0;
+	}
+
 	// Vector to store our points
 	std::vector<Point> points;
 	std::vector<Point> points_sorted_x;
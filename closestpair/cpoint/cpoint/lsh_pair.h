@@ -0,0 +1,293 @@
+﻿/**
+* Approximate closest pair for high dimensional vectors
+*
+* The divide and conquer strip argument in find_closest_pair() stops paying off
+* after a handful of dimensions, and brute force is O(n^2 d). For embeddings
+* (e.g. 128-D) we hash instead, with p-stable (Euclidean) locality sensitive
+* hashing: each hash is floor((a.v + b) / w) for a Gaussian vector a and an offset
+* b in [0, w), so vectors close in Euclidean distance land in the same bucket
+* whatever their length. Only vectors sharing a bucket get their exact distance
+* computed.
+*
+*   num_tables   - independent hash tables. More tables, higher recall, more memory.
+*   num_hashes   - hashes combined per table. More hashes, smaller buckets, lower recall.
+*   num_probes   - extra buckets looked at per vector and table (multi-probe). Each
+*                  one moves a single hash one step towards the slot boundary the
+*                  vector is closest to, so a few probes buy the recall of many tables.
+*   bucket_width - w. Should be a few times the distance of the pairs to be found.
+*
+* Vectors are stored row major in one flat float array, dim floats per vector.
+* The exact re-ranking inside buckets uses SSE when it is available.
+*
+* Paul Bupe Jr
+*/
+
+#pragma once
+
+#include <vector>
+#include <algorithm>
+#include <utility>
+#include <random>
+#include <limits>
+#include <cstdint>
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <xmmintrin.h>
+#define LSH_USE_SSE 1
+#endif
+
+
+struct LSHParams
+{
+	int num_tables = 8;
+	int num_hashes = 12;
+	int num_probes = 4;
+	float bucket_width = 1.0f;
+	unsigned seed = 7432;
+};
+
+// A pair of vector indices and the distance between them
+struct VectorPair
+{
+	int first, second;
+	double dist;
+};
+
+
+// Squared Euclidean distance between two dim long vectors
+inline float squared_dist(const float *a, const float *b, int dim)
+{
+	int i = 0;
+#ifdef LSH_USE_SSE
+	__m128 acc0 = _mm_setzero_ps(), acc1 = _mm_setzero_ps();
+	for (; i + 8 <= dim; i += 8)
+	{
+		__m128 d0 = _mm_sub_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i));
+		__m128 d1 = _mm_sub_ps(_mm_loadu_ps(a + i + 4), _mm_loadu_ps(b + i + 4));
+		acc0 = _mm_add_ps(acc0, _mm_mul_ps(d0, d0));
+		acc1 = _mm_add_ps(acc1, _mm_mul_ps(d1, d1));
+	}
+	float lanes[4];
+	_mm_storeu_ps(lanes, _mm_add_ps(acc0, acc1));
+	float sum = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+#else
+	float sum = 0;
+#endif
+	for (; i < dim; i++)
+	{
+		float d = a[i] - b[i];
+		sum += d * d;
+	}
+	return sum;
+}
+
+inline float dot_product(const float *a, const float *b, int dim)
+{
+	int i = 0;
+#ifdef LSH_USE_SSE
+	__m128 acc0 = _mm_setzero_ps(), acc1 = _mm_setzero_ps();
+	for (; i + 8 <= dim; i += 8)
+	{
+		acc0 = _mm_add_ps(acc0, _mm_mul_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i)));
+		acc1 = _mm_add_ps(acc1, _mm_mul_ps(_mm_loadu_ps(a + i + 4), _mm_loadu_ps(b + i + 4)));
+	}
+	float lanes[4];
+	_mm_storeu_ps(lanes, _mm_add_ps(acc0, acc1));
+	float sum = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+#else
+	float sum = 0;
+#endif
+	for (; i < dim; i++) { sum += a[i] * b[i]; }
+	return sum;
+}
+
+// Exact closest pair by comparing every pair, the D dimensional brute_force_pair()
+inline VectorPair brute_force_pair_nd(const std::vector<float> &data, int dim)
+{
+	int n = (int)(data.size() / dim);
+	VectorPair best = { -1, -1, std::numeric_limits<double>::infinity() };
+	float min = std::numeric_limits<float>::infinity();
+
+	for (int i = 0; i < n; ++i) {
+		for (int j = i + 1; j < n; ++j) {
+			float dist = squared_dist(&data[(size_t)i * dim], &data[(size_t)j * dim], dim);
+			if (dist < min) {
+				min = dist;
+				best = { i, j, 0 };
+			}
+		}
+	}
+
+	if (best.first != -1) best.dist = std::sqrt((double)min);
+	return best;
+}
+
+// Every pair closer than radius, found by brute force. Used to measure recall.
+inline std::vector<VectorPair> brute_force_near_pairs(const std::vector<float> &data, int dim, double radius)
+{
+	int n = (int)(data.size() / dim);
+	float r2 = (float)(radius * radius);
+	std::vector<VectorPair> pairs;
+
+	for (int i = 0; i < n; ++i) {
+		for (int j = i + 1; j < n; ++j) {
+			float dist = squared_dist(&data[(size_t)i * dim], &data[(size_t)j * dim], dim);
+			if (dist <= r2) pairs.push_back({ i, j, std::sqrt((double)dist) });
+		}
+	}
+	return pairs;
+}
+
+
+class LSHIndex
+{
+public:
+	LSHIndex(const std::vector<float> &data, int dim, const LSHParams &options)
+		: data(data), dim(dim), n((int)(data.size() / dim)), params(options)
+	{
+		// A probe is stored as one byte: the hash index and the direction to move it
+		params.num_hashes = std::max(1, std::min(params.num_hashes, 127));
+		params.num_probes = std::max(0, std::min(params.num_probes, params.num_hashes));
+		int hashes = params.num_hashes;
+		int probes = params.num_probes;
+		float width = params.bucket_width;
+
+		// Gaussian projections are 2-stable, so a.u - a.v is distributed like |u - v|
+		// times a standard normal, which is what makes the hash track distance
+		std::mt19937 rng(params.seed);
+		std::normal_distribution<float> gauss(0.0f, 1.0f);
+		std::uniform_real_distribution<float> offset(0.0f, width);
+		size_t num_funcs = (size_t)params.num_tables * hashes;
+		projections.resize(num_funcs * dim);
+		for (auto &v : projections) { v = gauss(rng); }
+		offsets.resize(num_funcs);
+		for (auto &v : offsets) { v = offset(rng); }
+
+		// A table's bucket key is sum(h_i * mult_i) mod 2^32 with random odd multipliers.
+		// Moving one hash by +-1 moves the key by +-mult_i, so probe keys are cheap, and a
+		// rare collision only adds candidates since every candidate is checked exactly.
+		multipliers.resize(num_funcs);
+		for (auto &v : multipliers) { v = uint32_t(rng()) | 1u; }
+
+		// Hash every vector into every table. Only the best num_probes moves per vector
+		// and table are kept, not the positions inside every slot.
+		keys.assign((size_t)params.num_tables * n, 0);
+		probe_moves.assign((size_t)params.num_tables * n * probes, 0);
+		tables.resize(params.num_tables);
+		std::vector<std::pair<float, uint8_t>> order(hashes);
+		for (int t = 0; t < params.num_tables; t++)
+		{
+			for (int i = 0; i < n; i++)
+			{
+				uint32_t key = 0;
+				for (int h = 0; h < hashes; h++)
+				{
+					size_t f = (size_t)t * hashes + h;
+					float x = (dot_product(&projections[f * dim], &data[(size_t)i * dim], dim) + offsets[f]) / width;
+					float slot = std::floor(x);
+					key += uint32_t((long long)slot) * multipliers[f];
+
+					// Distance to the nearer slot boundary, and which side it is on
+					float frac = x - slot;
+					order[h] = (frac < 0.5f) ? std::make_pair(frac, uint8_t(h << 1)) : std::make_pair(1.0f - frac, uint8_t((h << 1) | 1));
+				}
+				keys[(size_t)t * n + i] = key;
+				tables[t].push_back({ key, i });
+
+				std::partial_sort(order.begin(), order.begin() + probes, order.end());
+				for (int p = 0; p < probes; p++) { probe_moves[((size_t)t * n + i) * probes + p] = order[p].second; }
+			}
+			std::sort(tables[t].begin(), tables[t].end());
+		}
+	}
+
+	// Calls visit(i, j) for every candidate pair i != j: vectors sharing a bucket,
+	// plus each vector against the buckets reached by its probes. A pair may be
+	// visited more than once.
+	template <typename Visit>
+	void for_each_candidate(Visit visit) const
+	{
+		int hashes = params.num_hashes;
+		int probes = params.num_probes;
+
+		for (int t = 0; t < params.num_tables; t++)
+		{
+			const auto &table = tables[t];
+
+			// Pairs inside a bucket, each once
+			for (size_t start = 0; start < table.size(); )
+			{
+				size_t end = start + 1;
+				while (end < table.size() && table[end].first == table[start].first) end++;
+				for (size_t a = start; a < end; a++)
+				{
+					for (size_t b = a + 1; b < end; b++) { visit(table[a].second, table[b].second); }
+				}
+				start = end;
+			}
+
+			// Multi-probe: the neighbouring buckets most likely to hold a near vector are
+			// the ones across the slot boundaries the vector sits closest to
+			for (int i = 0; i < n && probes > 0; i++)
+			{
+				uint32_t key = keys[(size_t)t * n + i];
+				const uint8_t *moves = &probe_moves[((size_t)t * n + i) * probes];
+				for (int p = 0; p < probes; p++)
+				{
+					uint32_t mult = multipliers[(size_t)t * hashes + (moves[p] >> 1)];
+					uint32_t probe = (moves[p] & 1) ? key + mult : key - mult;
+					auto range = std::equal_range(table.begin(), table.end(), std::make_pair(probe, 0),
+						[](const std::pair<uint32_t, int> &lhs, const std::pair<uint32_t, int> &rhs) {return lhs.first < rhs.first; });
+					for (auto it = range.first; it != range.second; ++it) { visit(i, it->second); }
+				}
+			}
+		}
+	}
+	// Approximate closest pair: the closest of all candidate pairs
+	VectorPair closest_pair() const
+	{
+		int best_i = -1, best_j = -1;
+		float min = std::numeric_limits<float>::infinity();
+		for_each_candidate([&](int i, int j)
+		{
+			float dist = squared_dist(&data[(size_t)i * dim], &data[(size_t)j * dim], dim);
+			if (dist < min) { min = dist; best_i = std::min(i, j); best_j = std::max(i, j); }
+		});
+
+		VectorPair best = { best_i, best_j, std::numeric_limits<double>::infinity() };
+		if (best_i != -1) best.dist = std::sqrt((double)min);
+		return best;
+	}
+
+	// Near-duplicate mode: candidate pairs closer than radius, each once, sorted by index
+	std::vector<VectorPair> near_pairs(double radius) const
+	{
+		float r2 = (float)(radius * radius);
+		std::vector<VectorPair> pairs;
+		for_each_candidate([&](int i, int j)
+		{
+			float dist = squared_dist(&data[(size_t)i * dim], &data[(size_t)j * dim], dim);
+			if (dist <= r2) pairs.push_back({ std::min(i, j), std::max(i, j), std::sqrt((double)dist) });
+		});
+
+		std::sort(pairs.begin(), pairs.end(), [](const VectorPair &lhs, const VectorPair &rhs)
+		{return (lhs.first != rhs.first) ? lhs.first < rhs.first : lhs.second < rhs.second; });
+		pairs.erase(std::unique(pairs.begin(), pairs.end(), [](const VectorPair &lhs, const VectorPair &rhs)
+		{return lhs.first == rhs.first && lhs.second == rhs.second; }), pairs.end());
+		return pairs;
+	}
+
+private:
+	const std::vector<float> &data;
+	int dim;
+	int n;
+	LSHParams params;
+
+	std::vector<float> projections;		// num_tables * num_hashes Gaussian vectors of dim floats
+	std::vector<float> offsets;			// b of every hash, in [0, bucket_width)
+	std::vector<uint32_t> multipliers;	// Weight of every hash in its table's bucket key
+	std::vector<uint32_t> keys;			// Bucket key of every vector in every table
+	std::vector<uint8_t> probe_moves;	// num_probes moves per vector and table: hash << 1 | up
+	std::vector<std::vector<std::pair<uint32_t, int>>> tables;	// (key, vector) sorted by key
+};
@@ -0,0 +1,191 @@
+﻿/**
+* Batch mode shared by the solvers
+*
+* Instead of solving one hardcoded input file per process, a solver started in
+* batch mode reads a stream of jobs and solves them on a pool of worker threads.
+* Each worker owns one Workspace for its whole lifetime, so the vectors a solver
+* keeps there (edge lists, adjacency lists, union-find, sort buffers...) and the
+* worker's result string keep their capacity from one job to the next instead of
+* being allocated again. A result that has to wait for an earlier job is swapped
+* with a spare string that an earlier written result left behind, so the worker
+* keeps a warm buffer either way. Anything a solver allocates outside its
+* Workspace is still allocated per job.
+*
+* Job format: a line holding the number of data lines n, followed by those n
+* lines (the same lines the solver would read from its input file). Blank lines
+* between jobs are ignored. n must be a plain non-negative number no larger than
+* BATCH_MAX_JOB_LINES. A count line that is not gives an "Error: ..." result and
+* ends the stream, because there is no telling where the next job starts. A job
+* cut short by the end of the input also gets an "Error: ..." result. A local socket can be served by connecting it to
+* stdin/stdout, e.g. socat UNIX-LISTEN:/tmp/mst.sock EXEC:"boruvka --batch".
+*
+* Results are written in the same order as the jobs arrived, each one as soon as
+* it and every job before it are done. A malformed job gets an "Error: ..." line
+* as its result and does not affect the other jobs.
+*
+* Paul Bupe Jr
+*/
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <map>
+#include <algorithm>
+#include <utility>
+#include <istream>
+#include <cstdio>
+#include <cstdlib>
+#include <cerrno>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <exception>
+
+
+// Largest data line count a job may announce
+const long long BATCH_MAX_JOB_LINES = 1LL << 26;
+
+// Parses a job's count line. Returns -1 unless the whole line, apart from
+// surrounding blanks, is a number in 0..BATCH_MAX_JOB_LINES.
+inline long long parse_job_count(const std::string &line)
+{
+	const char *p = line.c_str();
+	while (*p == ' ' || *p == '\t') p++;
+	if (*p < '0' || *p > '9') return -1;
+
+	char *end;
+	errno = 0;
+	long long n = std::strtoll(p, &end, 10);
+	if (errno == ERANGE || n > BATCH_MAX_JOB_LINES) return -1;
+	while (*end == ' ' || *end == '\t' || *end == '\r') end++;
+	return (*end == '\0') ? n : -1;
+}
+
+// solve(Workspace &ws, const std::string &job, std::string &result) parses the data
+// lines in job and appends its output to result, or an "Error: ..." line if the job
+// is malformed. Returns the number of jobs solved.
+template <typename Workspace, typename Solve>
+long long run_batch(std::istream &in, std::FILE *out, Solve solve, unsigned num_threads = 0)
+{
+	if (num_threads == 0) num_threads = std::max(1u, std::thread::hardware_concurrency());
+
+	// Jobs waiting for a worker. Bounded so a fast reader cannot buffer the whole input.
+	// A job whose error is set was rejected by the reader and is not solved.
+	struct Job
+	{
+		long long id;
+		std::string text;
+		const char *error;
+	};
+	const size_t max_queued = 4 * num_threads;
+	std::deque<Job> jobs;
+	bool closed = false;
+	std::mutex job_mutex;
+	std::condition_variable job_ready, job_taken;
+
+	// Finished results waiting for the jobs before them, and the emptied buffers of
+	// results already written
+	std::map<long long, std::string> done;
+	std::vector<std::string> spare;
+	long long next_out = 0;
+	std::mutex out_mutex;
+
+	auto worker = [&]()
+	{
+		Workspace ws;
+		std::string result;
+
+		while (true)
+		{
+			Job job;
+			{
+				std::unique_lock<std::mutex> lock(job_mutex);
+				job_ready.wait(lock, [&] { return !jobs.empty() || closed; });
+				if (jobs.empty()) return;
+				job = std::move(jobs.front());
+				jobs.pop_front();
+			}
+			job_taken.notify_one();
+
+			// A job that runs out of memory gets an error line instead of taking the pool down
+			result.clear();
+			if (job.error) result = job.error;
+			else {
+				try { solve(ws, job.text, result); }
+				catch (const std::exception &e) { result = std::string("Error: ") + e.what() + "\n"; }
+			}
+
+			std::lock_guard<std::mutex> lock(out_mutex);
+			if (job.id == next_out) {
+				// Nothing before this job is pending, so write it straight from the worker's buffer
+				std::fwrite(result.data(), 1, result.size(), out);
+				next_out++;
+			}
+			else {
+				// Park the result and carry on with a spare buffer in its place
+				std::string parked;
+				if (!spare.empty()) {
+					parked.swap(spare.back());
+					spare.pop_back();
+				}
+				parked.swap(result);
+				done.emplace(job.id, std::move(parked));
+			}
+			while (!done.empty() && done.begin()->first == next_out)
+			{
+				std::string &text = done.begin()->second;
+				std::fwrite(text.data(), 1, text.size(), out);
+				text.clear();
+				spare.push_back(std::move(text));
+				done.erase(done.begin());
+				next_out++;
+			}
+			std::fflush(out);
+		}
+	};
+
+	std::vector<std::thread> pool;
+	for (unsigned i = 0; i < num_threads; i++) { pool.emplace_back(worker); }
+
+	// Read jobs on this thread. Parsing the data lines is left to the workers.
+	long long num_jobs = 0;
+	std::string line;
+	bool framed = true;
+	while (framed && std::getline(in, line))
+	{
+		if (line.find_first_not_of(" \t\r") == std::string::npos) continue;
+
+		Job job = { num_jobs++, std::string(), nullptr };
+		long long n = parse_job_count(line);
+		if (n < 0) {
+			job.error = "Error: bad job line count\n";
+			framed = false;
+		}
+		else {
+			long long i = 0;
+			for (; i < n && std::getline(in, line); i++)
+			{
+				job.text += line;
+				job.text += '\n';
+			}
+			if (i < n) job.error = "Error: input ended in the middle of a job\n";
+		}
+
+		std::unique_lock<std::mutex> lock(job_mutex);
+		job_taken.wait(lock, [&] { return jobs.size() < max_queued; });
+		jobs.push_back(std::move(job));
+		lock.unlock();
+		job_ready.notify_one();
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(job_mutex);
+		closed = true;
+	}
+	job_ready.notify_all();
+	for (auto &t : pool) { t.join(); }
+
+	return num_jobs;
+}